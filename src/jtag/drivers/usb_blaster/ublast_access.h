@@ -33,6 +33,7 @@ struct ublast_lowlevel {
 	int (*open)(struct ublast_lowlevel *low);
 	int (*close)(struct ublast_lowlevel *low);
 	int (*speed)(struct ublast_lowlevel *low, int speed);
+	int (*set_latency_timer)(struct ublast_lowlevel *low, uint8_t latency);
 
 	void *priv;
 };
@@ -78,6 +78,21 @@ static int ublast_ftd2xx_speed(struct ublast_lowlevel *low, int speed)
 	return ERROR_OK;
 }
 
+static int ublast_ftd2xx_set_latency(struct ublast_lowlevel *low,
+				     uint8_t latency)
+{
+	FT_STATUS status;
+	FT_HANDLE *ftdih = ublast_getftdih(low);
+
+	status = FT_SetLatencyTimer(*ftdih, latency);
+	if (status != FT_OK) {
+		LOG_ERROR("unable to set latency timer: %s",
+				ftd2xx_status_string(status));
+		return ERROR_JTAG_DEVICE_ERROR;
+	}
+	return ERROR_OK;
+}
+
 static int ublast_ftd2xx_init(struct ublast_lowlevel *low)
 {
 	FT_STATUS status;
@@ -177,6 +192,7 @@ static struct ublast_lowlevel low = {
 	.read = ublast_ftd2xx_read,
 	.write = ublast_ftd2xx_write,
 	.speed = ublast_ftd2xx_speed,
+	.set_latency_timer = ublast_ftd2xx_set_latency,
 	.priv = &info,
 };
 
@@ -92,6 +92,18 @@ static int ublast_ftdi_speed(struct ublast_lowlevel *low, int speed)
 	return ERROR_OK;
 }
 
+static int ublast_ftdi_set_latency(struct ublast_lowlevel *low, uint8_t latency)
+{
+	struct ftdi_context *ftdic = ublast_getftdic(low);
+
+	if (ftdi_set_latency_timer(ftdic, latency) < 0) {
+		LOG_ERROR("unable to set latency timer: %s",
+			  ftdi_get_error_string(ftdic));
+		return ERROR_JTAG_DEVICE_ERROR;
+	}
+	return ERROR_OK;
+}
+
 static int ublast_ftdi_init(struct ublast_lowlevel *low)
 {
 	uint8_t latency_timer;
@@ -146,6 +158,7 @@ static struct ublast_lowlevel low = {
 	.read = ublast_ftdi_read,
 	.write = ublast_ftdi_write,
 	.speed = ublast_ftdi_speed,
+	.set_latency_timer = ublast_ftdi_set_latency,
 	.priv = &info,
 };
 
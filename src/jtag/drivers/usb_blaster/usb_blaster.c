@@ -75,15 +75,23 @@
 /* Size of USB endpoint max packet size, ie. 64 bytes */
 #define BUF_LEN 64
 
+/* Size of the write aggregation buffer. The FT245 slices writes into
+ * BUF_LEN sized USB packets by itself; handing several KB to the lowlevel
+ * driver in one call amortizes the per-transfer overhead over many packets
+ * instead of paying it every 64 bytes. */
+#define WRITE_BUF_LEN 4096
+
 #define NO_TAP_SHIFT	0
 #define TAP_SHIFT	1
 
 struct ublast_info {
-	int pin6;
-	int pin8;
-	int tms;
-	int tdi;
-	uint8_t buf[BUF_LEN];
+	/*
+	 * Fully assembled bitbang output byte (LED, pin and TMS/TDI bits),
+	 * kept up-to-date at every pin change so the per-bit hot paths read
+	 * it instead of rebuilding it from separate pin variables.
+	 */
+	uint8_t out_value;
+	uint8_t buf[WRITE_BUF_LEN];
 	int bufidx;
 
 	char *lowlevel_name;
@@ -118,41 +126,60 @@ static struct drvs_map lowlevel_drivers_map[] = {
 /*
  * Access functions to lowlevel driver, agnostic of libftdi/libftdxx
  */
-static char *hexdump(uint8_t *buf, unsigned int size)
+#ifdef _DEBUG_JTAG_IO_
+static const char hex_digit[16] = "0123456789abcdef";
+
+/*
+ * Format the first DEBUG_JTAG_IOZ bytes of buf as hex into str, which must
+ * be at least 2 * DEBUG_JTAG_IOZ + 1 chars. Direct nibble lookup into a
+ * caller-provided buffer keeps both sprintf and a malloc/free pair off the
+ * debug path.
+ */
+static void hexdump(char *str, uint8_t *buf, unsigned int size)
 {
 	unsigned int i;
-	char *str = calloc(size * 2 + 1, 1);
 
-	for (i = 0; i < size; i++)
-		sprintf(str + 2*i, "%02x", buf[i]);
-	return str;
+	if (size > DEBUG_JTAG_IOZ)
+		size = DEBUG_JTAG_IOZ;
+	for (i = 0; i < size; i++) {
+		str[2 * i] = hex_digit[buf[i] >> 4];
+		str[2 * i + 1] = hex_digit[buf[i] & 0xf];
+	}
+	str[2 * size] = '\0';
 }
+#endif
 
 static int ublast_buf_read(uint8_t *buf, unsigned size, uint32_t *bytes_read)
 {
 	int ret = info.drv->read(info.drv, buf, size, bytes_read);
-	char *str = hexdump(buf, *bytes_read);
 
+#ifdef _DEBUG_JTAG_IO_
+	char str[2 * DEBUG_JTAG_IOZ + 1];
+
+	hexdump(str, buf, *bytes_read);
 	DEBUG_JTAG_IO("(size=%d, buf=[%s]) -> %u", size, str,
 		      *bytes_read);
-	free(str);
+#endif
 	return ret;
 }
 
 static int ublast_buf_write(uint8_t *buf, int size, uint32_t *bytes_written)
 {
 	int ret = info.drv->write(info.drv, buf, size, bytes_written);
-	char *str = hexdump(buf, *bytes_written);
 
+#ifdef _DEBUG_JTAG_IO_
+	char str[2 * DEBUG_JTAG_IOZ + 1];
+
+	hexdump(str, buf, *bytes_written);
 	DEBUG_JTAG_IO("(size=%d, buf=[%s]) -> %u", size, str,
 		      *bytes_written);
-	free(str);
+#endif
 	return ret;
 }
 
 static int nb_buf_remaining(void)
 {
-	return BUF_LEN - info.bufidx;
+	return WRITE_BUF_LEN - info.bufidx;
 }
 
 static void ublast_flush_buffer(void)
@@ -200,6 +227,16 @@ static void ublast_flush_buffer(void)
  * It isn't possible to read a data without transmitting data.
  */
 
+/* Maximum number of data bytes following a byte-shift mode header, ie. the
+ * largest value fitting in the 6-bit length field */
+#define MAX_SHIFT_LEN	63
+
+/* Maximum number of TDO bytes left pending in the dongle before the host
+ * drains them. The USB-Blaster read FIFO holds 384 bytes; staying well below
+ * that lets several byte-shift frames be written back-to-back without any
+ * risk of overflowing it. */
+#define MAX_PENDING_TDOS	256
+
 #define TCK		(1 << 0)
 #define TMS		(1 << 1)
 #define NCE		(1 << 2)
@@ -231,7 +268,7 @@ static void ublast_reset(int trst, int srst)
  * @abyte: the byte to queue
  *
  * Queues one byte in 'bitbang mode' to the USB Blaster. The byte is not
- * actually sent, but stored in a 64 bytes buffer. The write is performed once
+ * actually sent, but stored in the write buffer. The write is performed once
  * the buffer is filled, or if an explicit ublast_flush_buffer() is called.
  */
 static void ublast_queue_byte(uint8_t abyte)
@@ -241,8 +278,6 @@ static void ublast_queue_byte(uint8_t abyte)
 	info.buf[info.bufidx++] = abyte;
 	if (nb_buf_remaining() == 0)
 		ublast_flush_buffer();
-	DEBUG_JTAG_IO("(byte=0x%02x) (TDI = %d, TMS = %d, TCK = %d, LED = %d, READ = %d)", abyte,
-			(abyte&TDI)?1:0, (abyte&TMS)?1:0, (abyte&TCK)?1:0, (abyte&LED)?1:0, (abyte&READ)?1:0);
 }
 
 /**
@@ -253,16 +288,12 @@ static void ublast_queue_byte(uint8_t abyte)
  */
 static uint8_t ublast_build_out(enum scan_type type)
 {
-	uint8_t abyte = 0;
-
-	abyte |= info.tms ? TMS : 0;
-	abyte |= info.pin6 ? NCE : 0;
-	abyte |= info.pin8 ? NCS : 0;
-	abyte |= info.tdi ? TDI : 0;
-	abyte |= LED;
-	if (type == SCAN_IN || type == SCAN_IO)
-		abyte |= READ;
-	return abyte;
+	/*
+	 * SCAN_IN and SCAN_IO are the odd enum scan_type values, so bit0 of
+	 * the type is exactly the "read TDO back" flag : shift it straight
+	 * into the READ position (bit6) instead of branching on the type.
+	 */
+	return info.out_value | ((type & 1) << 6);
 }
 
 /**
@@ -275,9 +306,7 @@ static void ublast_clock_tms(int tms)
 {
 	uint8_t out;
 
-	DEBUG_JTAG_IO("(tms=%d)", !!tms);
-	info.tms = !!tms;
-	info.tdi = 0;
+	info.out_value = (info.out_value & ~(TMS | TDI)) | (tms ? TMS : 0);
 	out = ublast_build_out(SCAN_OUT);
 	ublast_queue_byte(out);
 	ublast_queue_byte(out | TCK);
@@ -292,12 +321,11 @@ static void ublast_idle_clock(void)
 {
 	uint8_t out = ublast_build_out(SCAN_OUT);
 
-	DEBUG_JTAG_IO(".");
 	ublast_queue_byte(out);
 }
 
 /**
- * ublast_clock_tdi - Output a TDI with bitbang mode
+ * ublast_clock_tdi_flip_tms - Output a TDI with bitbang mode, change JTAG state
  * @tdi: the TDI bit to be shifted out
  * @type: scan type (ie. does a readback of TDO is required)
  *
@@ -308,29 +336,9 @@ static void ublast_idle_clock(void)
  *
  * If a TDO is to be read back, the required read is requested (bitbang mode),
  * and the USB Blaster will send back a byte with bit0 reprensenting the TDO.
- */
-static void ublast_clock_tdi(int tdi, enum scan_type type)
-{
-	uint8_t out;
-
-	DEBUG_JTAG_IO("(tdi=%d)",  !!tdi);
-	info.tdi = !!tdi;
-
-	out = ublast_build_out(SCAN_OUT);
-	ublast_queue_byte(out);
-
-	out = ublast_build_out(type);
-	ublast_queue_byte(out | TCK);
-}
-
-/**
- * ublast_clock_tdi_flip_tms - Output a TDI with bitbang mode, change JTAG state
- * @tdi: the TDI bit to be shifted out
- * @type: scan type (ie. does a readback of TDO is required)
  *
- * This function is the same as ublast_clock_tdi(), but it changes also the TMS
- * while outputing the TDI. This should be the last TDI output of a TDI
- * sequence, which will change state from :
+ * The TMS is flipped while outputing the TDI, so this should be the last TDI
+ * output of a TDI sequence, which will change state from :
  *   - IRSHIFT -> IREXIT1
  *   - or DRSHIFT -> DREXIT1
  */
@@ -338,9 +346,7 @@ static void ublast_clock_tdi_flip_tms(int tdi, enum scan_type type)
 {
 	uint8_t out;
 
-	DEBUG_JTAG_IO("(tdi=%d)", !!tdi);
-	info.tdi = !!tdi;
-	info.tms = !info.tms;
+	info.out_value = ((info.out_value & ~TDI) | (tdi ? TDI : 0)) ^ TMS;
 
 	out = ublast_build_out(SCAN_OUT);
 	ublast_queue_byte(out);
@@ -355,23 +361,27 @@ static void ublast_clock_tdi_flip_tms(int tdi, enum scan_type type)
 /**
  * ublast_queue_bytes - queue bytes for the USB Blaster
  * @bytes: byte array
- * @nb_bytes: number of bytes (limited to 64)
+ * @nb_bytes: number of bytes (limited to the write buffer size)
  *
  * Queues bytes to be sent to the USB Blaster.
  *
- * As the USB endpoint can only accept 64 bytes, the caller should ensure enough
- * space is available by calling nb_buf_remaining().
- * If the 64 bytes buffer is filled, the write is issued to the USB device.
+ * The caller should ensure enough space is available by calling
+ * nb_buf_remaining().
+ * If the write buffer is filled, the write is issued to the USB device.
+ *
+ * The copy into the aggregation buffer is deliberate : neither libftdi nor
+ * ftd2xx exposes a scatter-gather write, so submitting header and payload
+ * as separate vectors would mean one USB transfer per byte-shift frame and
+ * give up the multi-frame aggregation that dominates throughput here. The
+ * memcpy is cheap compared to either.
  */
 static void ublast_queue_bytes(uint8_t *bytes, int nb_bytes)
 {
-	if (info.bufidx + nb_bytes > BUF_LEN) {
+	if (info.bufidx + nb_bytes > WRITE_BUF_LEN) {
 		LOG_ERROR("buggy code, should never queue more that %d bytes",
 			  info.bufidx + nb_bytes);
 		exit(-1);
 	}
-	DEBUG_JTAG_IO("(nb_bytes=%d, bytes=[0x%02x, ...])", nb_bytes,
-		      bytes ? bytes[0] : 0);
 	if (bytes)
 		memcpy(&info.buf[info.bufidx], bytes, nb_bytes);
 	else
@@ -394,11 +404,29 @@ static void ublast_queue_bytes(uint8_t *bytes, int nb_bytes)
  */
 static void ublast_tms_seq(const uint8_t *bits, int nb_bits)
 {
-	int i;
+	uint8_t base, pair[2][2];
+	int i, tms = 0;
 
 	DEBUG_JTAG_IO("(bits=%02x..., nb_bits=%d)", bits[0], nb_bits);
-	for (i = 0; i < nb_bits; i++)
-		ublast_clock_tms((bits[i / 8] >> (i % 8)) & 0x01);
+
+	/*
+	 * As for TDI bits, only two TCK-low/TCK-high output pairs exist, one
+	 * for tms=0 and one for tms=1. Build them once instead of letting
+	 * ublast_clock_tms() recompute the output byte for every bit.
+	 */
+	base = info.out_value & ~(TMS | TDI);
+	pair[0][0] = base;
+	pair[0][1] = base | TCK;
+	pair[1][0] = base | TMS;
+	pair[1][1] = base | TMS | TCK;
+
+	for (i = 0; i < nb_bits; i++) {
+		tms = (bits[i / 8] >> (i % 8)) & 0x01;
+		if (nb_buf_remaining() < 2)
+			ublast_flush_buffer();
+		ublast_queue_bytes(pair[tms], 2);
+	}
+	info.out_value = pair[tms][0];
 	ublast_idle_clock();
 }
 
@@ -438,6 +466,42 @@ static void ublast_path_move(struct pathmove_command *cmd)
 	ublast_idle_clock();
 }
 
+/*
+ * Cache of the TMS paths between the six stable TAP states, indexed by raw
+ * tap_state_t values. A length of 0xff marks a pair the core table does not
+ * cover (unstable states); those fall back to tap_get_tms_path() and its
+ * diagnostics. The cache is rebuilt if the 'tms_sequence' command switches
+ * the core's sequence table at runtime.
+ */
+static struct {
+	bool valid;
+	bool from_new_table;
+	uint8_t bits[16][16];
+	uint8_t len[16][16];
+} tms_cache;
+
+static void ublast_build_tms_cache(void)
+{
+	static const tap_state_t stable_states[] = {
+		TAP_RESET, TAP_IDLE, TAP_DRSHIFT, TAP_DRPAUSE,
+		TAP_IRSHIFT, TAP_IRPAUSE,
+	};
+	unsigned int i, j;
+
+	memset(tms_cache.len, 0xff, sizeof(tms_cache.len));
+	for (i = 0; i < ARRAY_SIZE(stable_states); i++)
+		for (j = 0; j < ARRAY_SIZE(stable_states); j++) {
+			tap_state_t from = stable_states[i];
+			tap_state_t to = stable_states[j];
+
+			tms_cache.bits[from][to] = tap_get_tms_path(from, to);
+			tms_cache.len[from][to] =
+				tap_get_tms_path_len(from, to);
+		}
+	tms_cache.from_new_table = tap_uses_new_tms_table();
+	tms_cache.valid = true;
+}
+
 /**
  * ublast_state_move - move JTAG state to the target state
  * @state: the target state
@@ -454,8 +518,16 @@ static void ublast_state_move(tap_state_t state)
 		  tap_state_name(state));
 	if (tap_get_state() == state)
 		return;
-	tms_scan = tap_get_tms_path(tap_get_state(), state);
-	tms_len = tap_get_tms_path_len(tap_get_state(), state);
+	if (!tms_cache.valid ||
+	    tms_cache.from_new_table != tap_uses_new_tms_table())
+		ublast_build_tms_cache();
+	tms_len = tms_cache.len[tap_get_state()][state];
+	if (tms_len != 0xff) {
+		tms_scan = tms_cache.bits[tap_get_state()][state];
+	} else {
+		tms_scan = tap_get_tms_path(tap_get_state(), state);
+		tms_len = tap_get_tms_path_len(tap_get_state(), state);
+	}
 	ublast_tms_seq(&tms_scan, tms_len);
 	tap_set_state(state);
 }
@@ -509,6 +581,7 @@ static int ublast_read_bitbang_tdos(uint8_t *buf, int nb_bits)
 	int nb1 = nb_bits;
 	int i, ret = ERROR_OK;
 	unsigned int retlen;
+	uint64_t v = 0;
 	uint8_t tmp[8];
 
 	DEBUG_JTAG_IO("%s(buf=%p, num_bits=%d)", __func__, buf, nb_bits);
@@ -520,11 +593,22 @@ static int ublast_read_bitbang_tdos(uint8_t *buf, int nb_bits)
 	ublast_flush_buffer();
 
 	ret = ublast_buf_read(tmp, nb1, &retlen);
-	for (i = 0; ret == ERROR_OK && i < nb1; i++)
-		if (tmp[i] & READ_TDO)
-			*buf |= (1 << i);
-		else
-			*buf &= ~(1 << i);
+	if (ret != ERROR_OK)
+		return ret;
+
+	/*
+	 * Pack the TDO bit (bit0) of the up to 8 received bytes into the
+	 * output byte without a branch per bit : bit i of the result is the
+	 * READ_TDO bit of byte i.
+	 *
+	 * Wider SIMD packing (PMOVMSKB-style) buys nothing here : only the
+	 * bitbang tail of a scan comes through this path, which is at most
+	 * 8 bits by construction - byte-shift mode TDOs already arrive
+	 * packed from the dongle.
+	 */
+	for (i = 0; i < nb1; i++)
+		v |= (uint64_t)(tmp[i] & READ_TDO) << i;
+	*buf = (uint8_t)v;
 	return ret;
 }
 
@@ -552,8 +636,40 @@ static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan, in
 	int nb8 = nb_bits / 8;
 	int nb1 = nb_bits % 8;
 	int nbfree, i, trans = 0, read_tdos;
-	uint8_t *tdos = calloc(1, nb_bits / 8 + 1);
-	static uint8_t byte0[BUF_LEN];
+	int pending, pending_idx;
+	uint8_t shift_hdr;
+	unsigned int tdos_len = nb_bits / 8 + 1;
+	static uint8_t tdos_scratch[16 * 1024];
+	uint8_t *tdos;
+
+#ifdef _DEBUG_JTAG_IO_
+	/*
+	 * Per-bit tracing was moved up here : one summary line per batch
+	 * instead of one line for every queued byte.
+	 */
+	if (bits) {
+		char str[2 * DEBUG_JTAG_IOZ + 1];
+
+		hexdump(str, bits, DIV_ROUND_UP(nb_bits, 8));
+		DEBUG_JTAG_IO("(bits=[%s], nb_bits=%d, scan=%d, tap_shift=%d)",
+			      str, nb_bits, scan, tap_shift);
+	} else {
+		DEBUG_JTAG_IO("(bits=NULL, nb_bits=%d, scan=%d, tap_shift=%d)",
+			      nb_bits, scan, tap_shift);
+	}
+#endif
+
+	/*
+	 * The driver serializes all scans through the global info, so a
+	 * static scratch buffer is safe : scans up to 128 kbits reuse it and
+	 * only larger ones pay for a heap allocation.
+	 */
+	if (tdos_len <= sizeof(tdos_scratch)) {
+		tdos = tdos_scratch;
+		memset(tdos, 0, tdos_len);
+	} else {
+		tdos = calloc(1, tdos_len);
+	}
 
 	/*
 	 * As the last TDI bit should always be output in bitbang mode in order
@@ -569,45 +685,99 @@ static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan, in
 		nb1 = 8;
 	}
 
+	/*
+	 * Whether TDO comes back is a property of the whole scan : derive it
+	 * (and the byte-shift header template) once per call, never per bit
+	 * or per frame.
+	 */
 	read_tdos = (scan == SCAN_IN || scan == SCAN_IO);
+	shift_hdr = SHMODE | (read_tdos ? READ : 0);
+	pending = 0;
+	pending_idx = 0;
 	for (i = 0; i < nb8; i += trans) {
+		/*
+		 * A byte-shift frame is a header plus at least one data byte :
+		 * flush now if the buffer cannot hold both, so that no frame
+		 * with an empty payload is ever emitted.
+		 */
+		if (nb_buf_remaining() < 2)
+			ublast_flush_buffer();
 		nbfree = nb_buf_remaining();
 		trans = MIN(nbfree - 1, nb8 - i);
+		trans = MIN(trans, MAX_SHIFT_LEN);
 
 		/*
 		 * Queue a byte-shift mode transmission, with as many bytes as
 		 * is possible with regard to :
 		 *  - current filling level of write buffer
 		 *  - remaining bytes to write in byte-shift mode
+		 *  - the 63 bytes payload limit of a byte-shift frame
 		 */
-		if (read_tdos)
-			ublast_queue_byte(SHMODE | READ | trans);
-		else
-			ublast_queue_byte(SHMODE | trans);
+		ublast_queue_byte(shift_hdr | trans);
 		if (bits)
 			ublast_queue_bytes(&bits[i], trans);
 		else
-			ublast_queue_bytes(byte0, trans);
-		if (read_tdos)
-			ublast_read_byteshifted_tdos(&tdos[i], trans);
+			ublast_queue_bytes(NULL, trans);
+
+		/*
+		 * Let the TDO bytes of several frames accumulate in the
+		 * dongle and drain them in one read, rather than stalling on
+		 * a USB round-trip after every frame.
+		 */
+		if (read_tdos) {
+			if (!pending)
+				pending_idx = i;
+			pending += trans;
+			if (pending >= MAX_PENDING_TDOS) {
+				ublast_read_byteshifted_tdos(&tdos[pending_idx],
+							     pending);
+				pending = 0;
+			}
+		}
 	}
+	if (read_tdos && pending)
+		ublast_read_byteshifted_tdos(&tdos[pending_idx], pending);
 
 	/*
 	 * Queue the remaining TDI bits in bitbang mode.
+	 *
+	 * Only two TCK-low/TCK-high byte pairs are possible for a given TMS
+	 * and scan type : one for tdi=0 and one for tdi=1. Build both pairs
+	 * once and queue them directly, rather than recomputing the output
+	 * byte for every single bit.
 	 */
-	for (i = 0; i < nb1; i++) {
-		int tdi = bits ? bits[nb8 + i / 8] & (1 << i) : 0;
-		if (tap_shift && bits && i == nb1 - 1)
+	if (nb1) {
+		uint8_t base, read_bit, pair[2][2];
+		int last = (tap_shift && bits) ? nb1 - 1 : nb1;
+		int tdi = 0;
+
+		base = info.out_value & ~TDI;
+		read_bit = read_tdos ? READ : 0;
+		pair[0][0] = base;
+		pair[0][1] = base | TCK | read_bit;
+		pair[1][0] = base | TDI;
+		pair[1][1] = base | TDI | TCK | read_bit;
+
+		for (i = 0; i < last; i++) {
+			tdi = bits ? !!(bits[nb8 + i / 8] & (1 << i)) : 0;
+
+			if (nb_buf_remaining() < 2)
+				ublast_flush_buffer();
+			ublast_queue_bytes(pair[tdi], 2);
+		}
+		info.out_value = pair[tdi][0];
+		if (last != nb1) {
+			tdi = bits[nb8 + last / 8] & (1 << last);
 			ublast_clock_tdi_flip_tms(tdi, scan);
-		else
-			ublast_clock_tdi(tdi, scan);
+		}
 	}
 	if (nb1 && read_tdos)
 		ublast_read_bitbang_tdos(&tdos[nb8], nb1);
 
 	if (bits)
 		memcpy(bits, tdos, DIV_ROUND_UP(nb_bits, 8));
-	free(tdos);
+	if (tdos != tdos_scratch)
+		free(tdos);
 
 	/*
 	 * Ensure clock is in lower state
@@ -615,19 +785,65 @@ static void ublast_queue_tdi(uint8_t *bits, int nb_bits, enum scan_type scan, in
 	ublast_idle_clock();
 }
 
+/**
+ * ublast_queue_zero_bits - clock out TCK cycles with TDI low
+ * @nb_bits: number of TCK cycles
+ *
+ * Specialized variant of ublast_queue_tdi() for runtest/stableclocks :
+ * every TDI bit is zero, nothing is read back and TMS never flips, so no
+ * TDO buffer is needed and the byte-shift payloads are plain zero fills.
+ */
+static void ublast_queue_zero_bits(int nb_bits)
+{
+	int nb8 = nb_bits / 8;
+	int nb1 = nb_bits % 8;
+	int i, trans;
+	uint8_t pair[2];
+
+	/*
+	 * Same normalization as ublast_queue_tdi() : always terminate with
+	 * at least one bitbang cycle so the clock is handed back in a known
+	 * state.
+	 */
+	if (nb8 > 0 && nb1 == 0) {
+		nb8--;
+		nb1 = 8;
+	}
+
+	while (nb8 > 0) {
+		if (nb_buf_remaining() < 2)
+			ublast_flush_buffer();
+		trans = MIN(nb_buf_remaining() - 1, nb8);
+		trans = MIN(trans, MAX_SHIFT_LEN);
+		ublast_queue_byte(SHMODE | trans);
+		ublast_queue_bytes(NULL, trans);
+		nb8 -= trans;
+	}
+
+	info.out_value &= ~TDI;
+	pair[0] = info.out_value;
+	pair[1] = info.out_value | TCK;
+	for (i = 0; i < nb1; i++) {
+		if (nb_buf_remaining() < 2)
+			ublast_flush_buffer();
+		ublast_queue_bytes(pair, 2);
+	}
+	ublast_idle_clock();
+}
+
 static void ublast_runtest(int cycles, tap_state_t state)
 {
 	DEBUG_JTAG_IO("%s(cycles=%i, end_state=%d)", __func__, cycles, state);
 
 	ublast_state_move(TAP_IDLE);
-	ublast_queue_tdi(NULL, cycles, SCAN_OUT,TAP_SHIFT);
+	ublast_queue_zero_bits(cycles);
 	ublast_state_move(state);
 }
 
 static void ublast_stableclocks(int cycles)
 {
 	DEBUG_JTAG_IO("%s(cycles=%i)", __func__, cycles);
-	ublast_queue_tdi(NULL, cycles, SCAN_OUT, TAP_SHIFT);
+	ublast_queue_zero_bits(cycles);
 }
 
 /**
@@ -644,8 +860,6 @@ static int ublast_scan(struct scan_command *cmd)
 	uint8_t *buf = NULL;
 	enum scan_type type;
 	int ret = ERROR_OK;
-	static const char * const type2str[] = { "", "SCAN_IN", "SCAN_OUT", "SCAN_IO" };
-	char *log_buf = NULL;
 
 	type = jtag_scan_type(cmd);
 	scan_bits = jtag_build_buffer(cmd, &buf);
@@ -655,12 +869,16 @@ static int ublast_scan(struct scan_command *cmd)
 	else
 		ublast_state_move(TAP_DRSHIFT);
 
-	log_buf = hexdump(buf, DIV_ROUND_UP(scan_bits, 8));
+#ifdef _DEBUG_JTAG_IO_
+	static const char * const type2str[] = { "", "SCAN_IN", "SCAN_OUT", "SCAN_IO" };
+	char log_buf[2 * DEBUG_JTAG_IOZ + 1];
+
+	hexdump(log_buf, buf, DIV_ROUND_UP(scan_bits, 8));
 	DEBUG_JTAG_IO("%s(scan=%s, type=%s, bits=%d, buf=[%s], end_state=%d)", __func__,
 		  cmd->ir_scan ? "IRSCAN" : "DRSCAN",
 		  type2str[type],
 		  scan_bits, log_buf, cmd->end_state);
-	free(log_buf);
+#endif
 
 	if(cmd->end_state == TAP_DRSHIFT)
 		ublast_queue_tdi(buf, scan_bits, type, NO_TAP_SHIFT);
@@ -714,6 +932,15 @@ static int ublast_execute_queue(void)
 			ublast_stableclocks(cmd->cmd.stableclocks->num_cycles);
 			break;
 		case JTAG_TLR_RESET:
+			/*
+			 * A state move only promises to reach its end state :
+			 * when several are queued back-to-back, the
+			 * intermediate targets are immediately superseded, so
+			 * skip ahead and emit one TMS sequence for the last
+			 * of the run instead of one per command.
+			 */
+			while (cmd->next && cmd->next->type == JTAG_TLR_RESET)
+				cmd = cmd->next;
 			ublast_state_move(cmd->cmd.statemove->end_state);
 			break;
 		case JTAG_PATHMOVE:
@@ -756,6 +983,9 @@ static int ublast_init(void)
 	unsigned int retlen;
 	int ret, i;
 
+	/* Keep the output enable LED on ; pin6/pin8 may already be set */
+	info.out_value |= LED;
+
 	if (info.lowlevel_name) {
 		for (i = 0; lowlevel_drivers_map[i].name; i++)
 			if (!strcmp(lowlevel_drivers_map[i].name, info.lowlevel_name))
@@ -786,6 +1016,13 @@ static int ublast_init(void)
 
 	ret = info.drv->open(info.drv);
 	if (ret == ERROR_OK) {
+		/*
+		 * Lower the FTDI latency timer to 1 ms : with the default the
+		 * chip holds back partially filled packets for up to 16 ms,
+		 * which bounds every TDO read-back round-trip.
+		 */
+		if (info.drv->set_latency_timer)
+			info.drv->set_latency_timer(info.drv, 1);
 		/*
 		 * Flush USB-Blaster queue fifos
 		 */
@@ -861,7 +1098,7 @@ COMMAND_HANDLER(ublast_handle_vid_pid_command)
 
 COMMAND_HANDLER(ublast_handle_pin_command)
 {
-	uint8_t out_value;
+	uint8_t out_value, pin_mask;
 
 	if (CMD_ARGC == 2) {
 		const char * const pin_name = CMD_ARGV[0];
@@ -873,15 +1110,20 @@ COMMAND_HANDLER(ublast_handle_pin_command)
 			return ERROR_COMMAND_SYNTAX_ERROR;
 		}
 
-		if (!strcmp(pin_name, "pin6")) {
-			info.pin6 = state;
-		} else if (!strcmp(pin_name, "pin8")) {
-			info.pin8 = state;
-		} else {
+		/*
+		 * Both valid names share the "pin" prefix : check it once and
+		 * dispatch on the digit instead of running a strcmp per name.
+		 */
+		if (strncmp(pin_name, "pin", 3) != 0 ||
+		    (pin_name[3] != '6' && pin_name[3] != '8') ||
+		    pin_name[4] != '\0') {
 			LOG_ERROR("%s: pin name must be \"pin6\" or \"pin8\"",
 					CMD_NAME);
 			return ERROR_COMMAND_SYNTAX_ERROR;
 		}
+		pin_mask = (pin_name[3] == '6') ? NCE : NCS;
+		info.out_value = (info.out_value & ~pin_mask) |
+				 (state ? pin_mask : 0);
 
 		if (info.drv) {
 			out_value = ublast_build_out(SCAN_OUT);
@@ -0,0 +1,430 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Spencer Oliver                                  *
+ *   spen@spen-soft.co.uk                                                  *
+ *                                                                         *
+ *   Copyright (C) 2008 by David T.L. Wong                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef MIPS32_H
+#define MIPS32_H
+
+#include <assert.h>
+
+#include "target.h"
+#include "mips32_pracc.h"
+
+#define MIPS32_COMMON_MAGIC		0xB320B320
+
+/* branch annotations for the accessors below: error paths are cold,
+ * keep the expected flow fall-through for icache density */
+#define mips32_likely(x)	__builtin_expect(!!(x), 1)
+#define mips32_unlikely(x)	__builtin_expect(!!(x), 0)
+
+/* offsets into mips32 core register cache; the first 32 entries match
+ * the architectural GPR numbering, so an index doubles as the rs/rt/rd
+ * field of an instruction operating on that register */
+enum
+{
+	MIPS32_REG_ZERO = 0,
+	MIPS32_REG_AT = 1,
+	MIPS32_REG_V0 = 2,
+	MIPS32_REG_V1 = 3,
+	MIPS32_REG_A0 = 4,
+	MIPS32_REG_A1 = 5,
+	MIPS32_REG_A2 = 6,
+	MIPS32_REG_A3 = 7,
+	MIPS32_REG_T0 = 8,
+	MIPS32_REG_T1 = 9,
+	MIPS32_REG_T2 = 10,
+	MIPS32_REG_T3 = 11,
+	MIPS32_REG_T4 = 12,
+	MIPS32_REG_T5 = 13,
+	MIPS32_REG_T6 = 14,
+	MIPS32_REG_T7 = 15,
+	MIPS32_REG_S0 = 16,
+	MIPS32_REG_S1 = 17,
+	MIPS32_REG_S2 = 18,
+	MIPS32_REG_S3 = 19,
+	MIPS32_REG_S4 = 20,
+	MIPS32_REG_S5 = 21,
+	MIPS32_REG_S6 = 22,
+	MIPS32_REG_S7 = 23,
+	MIPS32_REG_T8 = 24,
+	MIPS32_REG_T9 = 25,
+	MIPS32_REG_K0 = 26,
+	MIPS32_REG_K1 = 27,
+	MIPS32_REG_GP = 28,
+	MIPS32_REG_SP = 29,
+	MIPS32_REG_FP = 30,
+	MIPS32_REG_RA = 31,
+	MIPS32_REG_STATUS = 32,
+	MIPS32_REG_LO = 33,
+	MIPS32_REG_HI = 34,
+	MIPS32_REG_BADVADDR = 35,
+	MIPS32_REG_CAUSE = 36,
+	MIPS32_PC = 37,
+	MIPS32NUMCOREREGS
+};
+
+/* the pc cache slot as a function, for call sites that want an rvalue
+ * the optimizer can fold without spelling the raw index */
+static inline unsigned mips32_pc_index(void)
+{
+	return MIPS32_PC;
+}
+
+enum mips32_isa_mode
+{
+	MIPS32_ISA_MIPS32 = 0,
+	MIPS32_ISA_MIPS16E = 1,
+};
+
+/* Per-ISA soft breakpoint descriptor, bound at examine time to the
+ * byte images matching the target endianness; indexed by
+ * enum mips32_isa_mode so breakpoint paths select data instead of
+ * branching per instruction width. */
+struct mips32_isa_ops
+{
+	const uint8_t *sdbbp;
+	uint8_t sdbbp_len;
+};
+
+/* EJTAG IBS/DBS report the comparator count in a 4 bit field */
+#define MIPS32_MAX_COMPARATORS	15
+
+/* One bank of break comparators, laid out as parallel arrays with a
+ * bitmap of free slots; allocation is ctz(free_mask)/clear-bit and
+ * release is a set-bit, both constant time. */
+struct mips32_comparator_bank
+{
+	uint32_t free_mask;
+	uint32_t bp_value[MIPS32_MAX_COMPARATORS];
+	uint32_t reg_address[MIPS32_MAX_COMPARATORS];
+};
+
+/* Members are ordered hot-first: everything a halt/resume cycle touches
+ * (magic check, isa mode, EJTAG state, the register file) sits in the
+ * leading cache lines, while examine-time and breakpoint bookkeeping
+ * follows below the marker.  The struct is one allocation, so the cold
+ * tail simply lands on lines the fast path never pulls in. */
+struct mips32_common
+{
+	uint32_t common_magic;
+	/* small flags packed into the byte after the magic word; isa_mode
+	 * keeps enum mips32_isa_mode for its named values at the API
+	 * boundary, only the storage is a single bit */
+	struct {
+		uint8_t isa_mode:1;
+		uint8_t bp_scanned:1;
+	} flags;
+	struct reg_cache *core_cache;
+	struct mips_ejtag ejtag_info;
+	/* cache-line aligned: the whole file is streamed to/from pracc */
+	uint32_t core_regs[MIPS32NUMCOREREGS] __attribute__((aligned(64)));
+
+	/* --- cold below this point --- */
+
+	void *arch_info;
+
+	/* working area for fastdata access */
+	struct working_area *fast_data_area;
+
+	/* soft breakpoint descriptors, selected for the target endianness
+	 * at examine time; [MIPS32_ISA_MIPS32] and [MIPS32_ISA_MIPS16E] */
+	struct mips32_isa_ops isa_ops[2];
+
+	int num_inst_bpoints;
+	int num_data_bpoints;
+	struct mips32_comparator_bank inst_break;
+	struct mips32_comparator_bank data_break;
+
+	/* register cache to processor synchronization */
+	int (*read_core_reg)(struct target *target, int num);
+	int (*write_core_reg)(struct target *target, int num);
+	/* vectored form: refresh every core register in one pracc
+	 * transaction instead of 38 per-register callback dispatches */
+	int (*read_core_regs)(struct target *target);
+};
+
+/* Raw downcast for the hot register/memory access paths; the magic
+ * check costs nothing in NDEBUG builds and trips immediately on a
+ * mis-typed target in debug builds. */
+static inline struct mips32_common *
+target_to_mips32(struct target *target)
+{
+	struct mips32_common *mips32 = target->arch_info;
+
+	assert(mips32->common_magic == MIPS32_COMMON_MAGIC);
+	return mips32;
+}
+
+/* Checked variant for cold entry points fed with a caller-supplied
+ * target; returns NULL instead of asserting on a type mismatch. */
+static inline struct mips32_common *
+target_to_mips32_checked(struct target *target)
+{
+	struct mips32_common *mips32 = target->arch_info;
+
+	if (mips32_unlikely(mips32->common_magic != MIPS32_COMMON_MAGIC))
+		return NULL;
+	return mips32;
+}
+
+/* per-register side data for the reg cache; kept to an index plus the
+ * owning target - mips32_common is one target_to_mips32() away, so
+ * storing it 38 times per target bought nothing */
+struct mips32_core_reg
+{
+	uint8_t num;
+	struct target *target;
+};
+
+/* gdb describes a soft breakpoint by its byte length; 2 bytes means a
+ * MIPS16e SDBBP, anything else the full MIPS32 one */
+static inline const struct mips32_isa_ops *
+mips32_isa_ops_for_length(struct mips32_common *mips32, unsigned length)
+{
+	return &mips32->isa_ops[(length == 2)
+			? MIPS32_ISA_MIPS16E : MIPS32_ISA_MIPS32];
+}
+
+struct mips32_algorithm
+{
+	int common_magic;
+	enum mips32_isa_mode isa_mode;
+};
+
+/* major opcodes, instruction bits 31:26 */
+enum mips32_opcode
+{
+	MIPS32_OP_SPECIAL	= 0x00,
+	MIPS32_OP_BEQ		= 0x04,
+	MIPS32_OP_BNE		= 0x05,
+	MIPS32_OP_ADDI		= 0x08,
+	MIPS32_OP_ORI		= 0x0D,
+	MIPS32_OP_LUI		= 0x0F,
+	MIPS32_OP_COP0		= 0x10,
+	MIPS32_OP_LW		= 0x23,
+	MIPS32_OP_LBU		= 0x24,
+	MIPS32_OP_LHU		= 0x25,
+	MIPS32_OP_SB		= 0x28,
+	MIPS32_OP_SH		= 0x29,
+	MIPS32_OP_SW		= 0x2B,
+	MIPS32_OP_PREF		= 0x33,
+};
+
+/* SPECIAL minor opcodes, instruction bits 5:0; values here may legally
+ * coincide with major opcodes above (e.g. JR/ADDI, AND/LBU) because
+ * they select through a different field */
+enum mips32_funct
+{
+	MIPS32_OP_SRL		= 0x03,
+	MIPS32_OP_JR		= 0x08,
+	MIPS32_OP_MFHI		= 0x10,
+	MIPS32_OP_MTHI		= 0x11,
+	MIPS32_OP_MFLO		= 0x12,
+	MIPS32_OP_MTLO		= 0x13,
+	MIPS32_OP_AND		= 0x24,
+	MIPS32_OP_XOR		= 0x26,
+};
+
+/* COP0 rs field values */
+enum mips32_cop0_op
+{
+	MIPS32_COP0_MF		= 0x00,
+	MIPS32_COP0_MT		= 0x04,
+};
+
+/* COP0 register numbers (select 0) the context dump stubs touch; lo
+ * and hi are not COP0 registers and move through MFLO/MFHI instead */
+enum mips32_cop0_reg
+{
+	MIPS32_C0_BADVADDR	= 8,
+	MIPS32_C0_STATUS	= 12,
+	MIPS32_C0_CAUSE		= 13,
+	MIPS32_C0_DEPC		= 24,
+};
+
+/* field-width invariants the encoders rely on; with these proven the
+ * encoders need no runtime masking of the opcode fields */
+_Static_assert(MIPS32_OP_PREF < 0x40, "major opcode must fit in 6 bits");
+_Static_assert(MIPS32_OP_XOR < 0x40, "SPECIAL funct must fit in 6 bits");
+_Static_assert(MIPS32_COP0_MT < 0x20, "COP0 rs value must fit in 5 bits");
+_Static_assert(MIPS32NUMCOREREGS == 38,
+		"pracc register load/store sequences assume this layout");
+_Static_assert(MIPS32_PC == MIPS32NUMCOREREGS - 1,
+		"pc is expected to be the last cached register");
+
+#define MIPS32_R_INST(opcode, rs, rt, rd, shamt, funct)	(((opcode) << 26) |((rs) << 21) | ((rt) << 16) | ((rd) << 11)| ((shamt) << 6) | (funct))
+#define MIPS32_I_INST(opcode, rs, rt, immd)	(((opcode) << 26) |((rs) << 21) | ((rt) << 16) | (immd))
+#define MIPS32_J_INST(opcode, addr)	(((opcode) << 26) |(addr))
+
+/* Inline encoders for instruction sequences built or patched at runtime.
+ *
+ * The textual macros above stay around because C only allows constant
+ * expressions in the static const code arrays used by mips32_pracc.c;
+ * everything assembled on the fly should go through these instead, so
+ * the compiler can fold the fixed opcode fields once per call site.
+ */
+static inline uint32_t __attribute__((const)) mips32_r_inst(uint32_t opcode, uint32_t rs,
+		uint32_t rt, uint32_t rd, uint32_t shamt, uint32_t funct)
+{
+	return (opcode << 26) | (rs << 21) | (rt << 16)
+		| (rd << 11) | (shamt << 6) | funct;
+}
+
+static inline uint32_t __attribute__((const)) mips32_i_inst(uint32_t opcode, uint32_t rs,
+		uint32_t rt, uint32_t immd)
+{
+	return (opcode << 26) | (rs << 21) | (rt << 16) | (immd & 0xffff);
+}
+
+static inline uint32_t __attribute__((const)) mips32_j_inst(uint32_t opcode, uint32_t addr)
+{
+	return (opcode << 26) | addr;
+}
+
+/* mnemonic wrappers, same operand order as the macros below */
+static inline uint32_t __attribute__((const)) mips32_lw(uint32_t reg, uint32_t off, uint32_t base)
+{
+	return mips32_i_inst(MIPS32_OP_LW, base, reg, off);
+}
+
+static inline uint32_t __attribute__((const)) mips32_sw(uint32_t reg, uint32_t off, uint32_t base)
+{
+	return mips32_i_inst(MIPS32_OP_SW, base, reg, off);
+}
+
+static inline uint32_t __attribute__((const)) mips32_lui(uint32_t reg, uint32_t val)
+{
+	return mips32_i_inst(MIPS32_OP_LUI, 0, reg, val);
+}
+
+static inline uint32_t __attribute__((const)) mips32_ori(uint32_t tar, uint32_t src, uint32_t val)
+{
+	return mips32_i_inst(MIPS32_OP_ORI, src, tar, val);
+}
+
+/* append one instruction to a runtime-assembled sequence */
+static inline uint32_t *mips32_emit(uint32_t *p, uint32_t inst)
+{
+	*p++ = inst;
+	return p;
+}
+
+/* Store one instruction word into a target-endian byte stream and
+ * return the advanced pointer. With the endianness hoisted to a
+ * loop-invariant flag this inlines to a plain (possibly byte-swapped)
+ * store per word, so a whole loader image can be converted and then
+ * pushed with a single block write. */
+static inline uint8_t *mips32_put_insn(uint8_t *p, uint32_t insn, bool big_endian)
+{
+	if (big_endian)
+		h_u32_to_be(p, insn);
+	else
+		h_u32_to_le(p, insn);
+	return p + 4;
+}
+
+/* load a 32 bit immediate into a GPR with the shortest sequence:
+ * lui alone, ori alone, or the full lui/ori pair */
+static inline uint32_t *mips32_emit_li32(uint32_t *p, uint32_t reg, uint32_t val)
+{
+	if ((val & 0xffff) == 0)
+		p = mips32_emit(p, mips32_lui(reg, val >> 16));
+	else if ((val >> 16) == 0)
+		p = mips32_emit(p, mips32_ori(reg, 0, val));
+	else
+	{
+		p = mips32_emit(p, mips32_lui(reg, val >> 16));
+		p = mips32_emit(p, mips32_ori(reg, reg, val & 0xffff));
+	}
+	return p;
+}
+
+#define MIPS32_NOP					0
+#define MIPS32_ADDI(tar, src, val)	MIPS32_I_INST(MIPS32_OP_ADDI, src, tar, val)
+#define MIPS32_AND(reg, off, val)	MIPS32_R_INST(0, off, val, reg, 0, MIPS32_OP_AND)
+#define MIPS32_B(off)				MIPS32_BEQ(0, 0, off)
+#define MIPS32_BEQ(src,tar,off)		MIPS32_I_INST(MIPS32_OP_BEQ, src, tar, off)
+#define MIPS32_BNE(src,tar,off)		MIPS32_I_INST(MIPS32_OP_BNE, src, tar, off)
+#define MIPS32_JR(reg)				MIPS32_R_INST(0, reg, 0, 0, 0, MIPS32_OP_JR)
+#define MIPS32_MFC0(gpr, cpr, sel)	MIPS32_R_INST(MIPS32_OP_COP0, MIPS32_COP0_MF, gpr, cpr, 0, sel)
+#define MIPS32_MTC0(gpr,cpr, sel)	MIPS32_R_INST(MIPS32_OP_COP0, MIPS32_COP0_MT, gpr, cpr, 0, sel)
+#define MIPS32_LBU(reg, off, base)	MIPS32_I_INST(MIPS32_OP_LBU, base, reg, off)
+#define MIPS32_LHU(reg, off, base)	MIPS32_I_INST(MIPS32_OP_LHU, base, reg, off)
+#define MIPS32_LUI(reg, val)		MIPS32_I_INST(MIPS32_OP_LUI, 0, reg, val)
+#define MIPS32_LW(reg, off, base)	MIPS32_I_INST(MIPS32_OP_LW, base, reg, off)
+#define MIPS32_MFLO(reg)			MIPS32_R_INST(0, 0, 0, reg, 0, MIPS32_OP_MFLO)
+#define MIPS32_MFHI(reg)			MIPS32_R_INST(0, 0, 0, reg, 0, MIPS32_OP_MFHI)
+#define MIPS32_MTLO(reg)			MIPS32_R_INST(0, reg, 0, 0, 0, MIPS32_OP_MTLO)
+#define MIPS32_MTHI(reg)			MIPS32_R_INST(0, reg, 0, 0, 0, MIPS32_OP_MTHI)
+#define MIPS32_ORI(tar, src, val)	MIPS32_I_INST(MIPS32_OP_ORI, src, tar, val)
+/* pref hint,off(base); decodes on every MIPS32 core, as a nop at worst */
+#define MIPS32_PREF(hint, off, base)	MIPS32_I_INST(MIPS32_OP_PREF, base, hint, off)
+#define MIPS32_SB(reg, off, base)	MIPS32_I_INST(MIPS32_OP_SB, base, reg, off)
+#define MIPS32_SH(reg, off, base)	MIPS32_I_INST(MIPS32_OP_SH, base, reg, off)
+#define MIPS32_SW(reg, off, base)	MIPS32_I_INST(MIPS32_OP_SW, base, reg, off)
+#define MIPS32_XOR(reg, val1, val2)	MIPS32_R_INST(0, val1, val2, reg, 0, MIPS32_OP_XOR)
+#define MIPS32_SRL(reg, src, off)	MIPS32_R_INST(0, 0, src, reg, off, MIPS32_OP_SRL)
+
+/* ejtag specific instructions */
+#define MIPS32_DRET					0x4200001F
+#define MIPS32_SDBBP				0x7000003F
+#define MIPS16_SDBBP				0xE801
+
+/* SDBBP byte images for both target endiannesses */
+extern const uint8_t mips32_sdbbp_bytes_le[4];
+extern const uint8_t mips32_sdbbp_bytes_be[4];
+extern const uint8_t mips16_sdbbp_bytes_le[2];
+extern const uint8_t mips16_sdbbp_bytes_be[2];
+
+int mips32_arch_state(struct target *target);
+
+const char *mips32_op_name(uint32_t instruction);
+
+int mips32_init_arch_info(struct target *target,
+		struct mips32_common *mips32, struct jtag_tap *tap);
+
+int mips32_restore_context(struct target *target);
+int mips32_save_context(struct target *target);
+
+struct reg_cache *mips32_build_reg_cache(struct target *target);
+
+int mips32_run_algorithm(struct target *target,
+		int num_mem_params, struct mem_param *mem_params,
+		int num_reg_params, struct reg_param *reg_params,
+		uint32_t entry_point, uint32_t exit_point,
+		int timeout_ms, void *arch_info);
+
+int mips32_configure_break_unit(struct target *target);
+
+int mips32_enable_interrupts(struct target *target, int enable);
+
+int mips32_examine(struct target *target);
+
+int mips32_register_commands(struct command_context *cmd_ctx);
+
+int mips32_get_gdb_reg_list(struct target *target,
+		struct reg **reg_list[], int *reg_list_size);
+int mips32_checksum_memory(struct target *target, uint32_t address,
+		uint32_t count, uint32_t* checksum);
+int mips32_blank_check_memory(struct target *target,
+		uint32_t address, uint32_t count, uint32_t* blank);
+
+#endif	/*MIPS32_H*/